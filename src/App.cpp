@@ -17,6 +17,18 @@ namespace {
 
     ul::JSFunction toggleTerminal;
     ul::JSFunction newTab;
+
+    // Makes arbitrary text safe to embed into a JS template literal
+    std::string escapeTemplate(const std::string &str) {
+        auto result = std::string();
+        for (auto ch : str) {
+            if (ch == '\\' || ch == '`' || ch == '$') {
+                result += '\\';
+            }
+            result += ch;
+        }
+        return result;
+    }
 }
 
 App::App()
@@ -26,7 +38,15 @@ App::App()
                              Settings::settings.height,
                              false,
                              ul::kWindowFlags_Resizable | ul::kWindowFlags_Maximizable) }
-, overlay{ ul::Overlay::Create(window, 1, 1, 0, 0) } {
+, overlay{ ul::Overlay::Create(window, 1, 1, 0, 0) }
+, saver{ [this](const std::string &filename, const std::error_code &err) {
+    // Only failures are shown and they stay until the same file saves successfully, runStatus belongs to the runner
+    auto file = '`' + escapeTemplate(filename) + '`';
+    auto name = escapeTemplate(bf::path(filename).filename().string());
+    PostJS(err ? "saveStatus.setAttribute('data-filename', " + file + "); "
+                 "saveStatus.innerText = `Не вдалося зберегти " + name + ": " + escapeTemplate(err.message()) + '`'
+               : "if (saveStatus.getAttribute('data-filename') === " + file + ") saveStatus.innerText = ''");
+} } {
     CoInitialize(nullptr);
 
     app->set_listener(this);
@@ -120,16 +140,24 @@ std::pair<ul::String, ul::String> openDialog(HWND window) {
     return {};
 }
 
-inline void writeFile(const char* filename) {
-    std::ofstream(filename) << ((ul::String) ul::JSEval("codearea.value")).utf8().data();
+inline std::string codeAreaValue() {
+    return ((ul::String) ul::JSEval("codearea.value")).utf8().data();
 }
 
-void App::BuildAndRun(const ul::JSObject&, const ul::JSArgs&) {
+void App::PostJS(std::string script) {
+    auto lock = std::lock_guard(jsCallbacksMutex);
+    jsCallbacks.emplace(std::move(script));
+}
+
+void App::Launch(RunMode mode) {
     if (!ul::JSEval("activeTab").ToBoolean() || runner.IsRunning()) {
         return;
     }
 
     ul::JSEval("terminal.value = ''");
+    ul::JSEval(mode == RunMode::Profile
+               ? "profile.value = 'Профілювання...'; profile.classList.remove('hidden')"
+               : "profile.classList.add('hidden')");
     if (ul::JSEval("terminal.parentElement.classList.contains('hidden')").ToBoolean()) {
         toggleTerminal({});
     } else {
@@ -138,18 +166,32 @@ void App::BuildAndRun(const ul::JSObject&, const ul::JSArgs&) {
 
     auto filename = ul::JSEval("activeTab.getAttribute('data-filename') !== 'null'").ToBoolean()
                     ? std::string(((ul::String) ul::JSEval("activeTab.getAttribute('data-filename')")).utf8().data())
-                    : (bf::temp_directory_path() / bf::unique_path()).string() + ".cpp";
-    writeFile(filename.c_str());
+                    : std::string();
+    auto source = codeAreaValue();
+    if (!filename.empty()) {
+        saver.Save(filename, source, Settings::settings.syncOnSave);
+    }
 
     std::thread(
             &ProcessRunner::BuildAndRun,
             &runner,
             filename,
-            [this](const std::string &message) { jsCallbacks.emplace("terminal.value += `" + message + '`'); },
-            [this](const std::string &message) { jsCallbacks.emplace("runStatus.innerText = `" + message + '`'); }
+            std::move(source),
+            mode,
+            [this](const std::string &message) { PostJS("terminal.value += `" + message + '`'); },
+            [this](const std::string &message) { PostJS("runStatus.innerText = `" + message + '`'); },
+            [this](const std::string &report) { PostJS("profile.value = `" + escapeTemplate(report) + '`'); }
     ).detach();
 }
 
+void App::BuildAndRun(const ul::JSObject&, const ul::JSArgs&) {
+    Launch(RunMode::Normal);
+}
+
+void App::ProfileAndRun(const ul::JSObject&, const ul::JSArgs&) {
+    Launch(RunMode::Profile);
+}
+
 void App::OnStdIn(const ul::JSObject&, const ul::JSArgs& args) {
     if (!runner.IsRunning()) {
         return;
@@ -202,7 +244,7 @@ void App::SaveFile(const ul::JSObject&, const ul::JSArgs&) {
     }
 
     auto filename = (ul::String) ul::JSEval("activeTab.getAttribute('data-filename')");
-    writeFile(filename.utf8().data());
+    saver.Save(filename.utf8().data(), codeAreaValue(), Settings::settings.syncOnSave);
 }
 
 void App::OpenSettings(const ul::JSObject&, const ul::JSArgs&) {
@@ -242,9 +284,14 @@ void App::Copy(const ul::JSObject&, const ul::JSArgs&) {
 }
 
 void App::OnUpdate() {
-    while (!jsCallbacks.empty()) {
-        ul::JSEval(jsCallbacks.front().c_str());
-        jsCallbacks.pop();
+    auto callbacks = std::queue<std::string>();
+    {
+        auto lock = std::lock_guard(jsCallbacksMutex);
+        std::swap(callbacks, jsCallbacks);
+    }
+    while (!callbacks.empty()) {
+        ul::JSEval(callbacks.front().c_str());
+        callbacks.pop();
     }
 
     if (closeSettings) {
@@ -269,6 +316,9 @@ bool App::OnKeyEvent(const ul::KeyEvent& evt) {
         case 'N':
             newTab({});
             break;
+        case 'P':
+            ProfileAndRun({}, {});
+            break;
         case 'Q':
             OnClose(window.get());
             break;
@@ -297,8 +347,10 @@ void App::OnClose(ul::Window *) {
                                   << Settings::settings.libPath << '\n'
                                   << Settings::settings.compiler << '\n'
                                   << window->width() << ' ' << window->height() << '\n'
-                                  << ul::JSEval("terminal.parentElement.classList.contains('hidden')").ToBoolean();
+                                  << ul::JSEval("terminal.parentElement.classList.contains('hidden')").ToBoolean() << '\n'
+                                  << Settings::settings.syncOnSave;
 
+    saver.Flush();
     std::exit(0);
 }
 
@@ -314,6 +366,7 @@ void App::OnDOMReady(ul::View *caller, uint64_t frame_id, bool is_main_frame, co
 
     global["quit"] = JSCallback([this](const ul::JSObject&, const ul::JSArgs&) { OnClose(window.get()); });
     global["buildAndRun"] = BindJSCallback(&App::BuildAndRun);
+    global["profileAndRun"] = BindJSCallback(&App::ProfileAndRun);
     global["stdin"] = BindJSCallback(&App::OnStdIn);
     global["openSettings"] = BindJSCallback(&App::OpenSettings);
     global["saveDialog"] = BindJSCallback(&App::SaveFile);
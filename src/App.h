@@ -4,8 +4,10 @@
 #include <AppCore/AppCore.h>
 #include <string>
 #include <queue>
+#include <mutex>
 #include "Settings.h"
 #include "ProcessRunner.h"
+#include "FileSaver.h"
 
 namespace ul = ultralight;
 
@@ -26,13 +28,18 @@ private:
     ul::RefPtr<ul::Window> window;
     ul::RefPtr<ul::Overlay> overlay;
 
+    std::mutex jsCallbacksMutex;
     std::queue<std::string> jsCallbacks;
     ProcessRunner runner;
+    FileSaver saver;
 
     std::unique_ptr<Settings> settings;
     bool closeSettings = false;
 
+    void PostJS(std::string script);
+    void Launch(RunMode mode);
     void BuildAndRun(const ul::JSObject&, const ul::JSArgs&);
+    void ProfileAndRun(const ul::JSObject&, const ul::JSArgs&);
     void OnStdIn(const ul::JSObject&, const ul::JSArgs& args);
     void SaveFile(const ul::JSObject&, const ul::JSArgs&);
     void OpenSettings(const ul::JSObject&, const ul::JSArgs&);
@@ -0,0 +1,105 @@
+#include "FileSaver.h"
+
+#include <cstdio>
+#include <boost/filesystem.hpp>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace bf = boost::filesystem;
+
+FileSaver::FileSaver(std::function<void(const std::string&, const std::error_code&)> onSaved)
+: onSaved{ std::move(onSaved) }
+, worker{ &FileSaver::Loop, this } {
+}
+
+FileSaver::~FileSaver() {
+    {
+        auto lock = std::lock_guard(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void FileSaver::Save(const std::string& filename, std::string contents, bool sync) {
+    auto save = Pending{ std::move(contents), sync };
+    {
+        auto lock = std::lock_guard(mutex);
+        if (auto [it, inserted] = pending.try_emplace(filename, std::move(save)); inserted) {
+            order.push_back(filename);
+        } else {
+            it->second = std::move(save);
+        }
+    }
+    wake.notify_one();
+}
+
+void FileSaver::Flush() {
+    auto lock = std::unique_lock(mutex);
+    idle.wait(lock, [this] { return order.empty() && !busy; });
+}
+
+std::error_code writeAtomically(const std::string& filename, const std::string& contents, bool sync) {
+    auto err = std::error_code();
+    auto target = bf::path(filename);
+    auto temp = target.parent_path() / bf::unique_path("." + target.filename().string() + ".%%%%-%%%%.tmp");
+
+    auto file = std::fopen(temp.string().c_str(), "wb");
+    if (!file) {
+        return {errno, std::generic_category()};
+    }
+
+    auto written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size() && !std::fflush(file);
+    if (written && sync) {
+#ifdef _WIN32
+        written = !_commit(_fileno(file));
+#else
+        written = !fsync(fileno(file));
+#endif
+    }
+    if (!written) {
+        err = {errno, std::generic_category()};
+    }
+    if (std::fclose(file) && !err) {
+        err = {errno, std::generic_category()};
+    }
+
+    if (!err) {
+        auto ec = boost::system::error_code();
+        bf::rename(temp, target, ec);
+        err = ec;
+    }
+    if (err) {
+        auto ec = boost::system::error_code();
+        bf::remove(temp, ec);
+    }
+    return err;
+}
+
+void FileSaver::Loop() {
+    auto lock = std::unique_lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !order.empty(); });
+        if (order.empty()) {
+            return;
+        }
+
+        auto filename = std::move(order.front());
+        order.pop_front();
+        auto save = std::move(pending.extract(filename).mapped());
+        busy = true;
+
+        lock.unlock();
+        auto err = writeAtomically(filename, save.contents, save.sync);
+        onSaved(filename, err);
+        lock.lock();
+
+        busy = false;
+        if (order.empty()) {
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef C_EDIT_FILESAVER_H
+#define C_EDIT_FILESAVER_H
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <system_error>
+
+// Writes files on a dedicated I/O thread. Each save goes to a temp file next to the target,
+// is optionally fsync'ed and then renamed over it. With sync on, a crash never leaves a truncated file;
+// without it the rename may reach the disk before the data does.
+// Saves of the same file that are still waiting in the queue are coalesced into the latest one.
+class FileSaver {
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<std::string> order;
+    struct Pending {
+        std::string contents;
+        bool sync;
+    };
+
+    std::unordered_map<std::string, Pending> pending;
+    bool busy = false;
+    bool stopping = false;
+    std::function<void(const std::string&, const std::error_code&)> onSaved;
+    std::thread worker;
+
+    void Loop();
+public:
+    explicit FileSaver(std::function<void(const std::string&, const std::error_code&)> onSaved);
+    ~FileSaver();
+
+    // With `sync` the data is flushed to the disk before the temp file replaces the original.
+    void Save(const std::string& filename, std::string contents, bool sync);
+
+    // Blocks until every queued save has hit the disk.
+    void Flush();
+};
+
+
+#endif //C_EDIT_FILESAVER_H
@@ -32,8 +32,12 @@ void ProcessRunner::Input(char ch) {
     }
 }
 
-std::vector<std::string> makeArgs(const std::string& filename, const std::string& exe) {
-    auto args = std::vector<std::string>{filename, "-o", exe};
+std::vector<std::string> makeArgs(const std::string& filename, const std::string& exe, RunMode mode) {
+    // Pick the language the configured driver would: g++/clang++ treat every file as C++,
+    // gcc/clang only switch to C for .c files
+    auto driver = bf::path(Settings::settings.compiler).stem().string();
+    auto language = !driver.ends_with("++") && bf::path(filename).extension() == ".c" ? "c" : "c++";
+    auto args = std::vector<std::string>{"-x", language, "-", "-x", "none", "-o", exe};
 
     if (!Settings::settings.flags.empty()) {
         auto stream = std::stringstream(Settings::settings.flags);
@@ -44,12 +48,18 @@ std::vector<std::string> makeArgs(const std::string& filename, const std::string
 
     if (!Settings::settings.includePath.empty()) {
         args.emplace_back("-I");
-        args.emplace_back(Settings::settings.includePath);
+        args.emplace_back(bf::absolute(Settings::settings.includePath).string());
     }
 
     if (!Settings::settings.libPath.empty()) {
         args.emplace_back("-L");
-        args.emplace_back(Settings::settings.libPath);
+        args.emplace_back(bf::absolute(Settings::settings.libPath).string());
+    }
+
+    // After the user's flags, so a stray -g0 doesn't leave the profiler without line tables.
+    // DWARF 4 because addr2line ignores #line file names in DWARF 5 line tables.
+    if (mode == RunMode::Profile) {
+        args.emplace_back("-gdwarf-4");
     }
 
     return args;
@@ -62,18 +72,46 @@ std::pair<std::error_code, bp::child> spawn(const bf::path& process, Args&&... a
     return {err, std::move(child)};
 }
 
+// Source is fed through stdin, so point diagnostics back at the real file with a #line directive.
+std::string lineDirective(const std::string& filename) {
+    if (filename.empty()) {
+        return {};
+    }
+
+    auto result = std::string("#line 1 \"");
+    for (auto ch : filename) {
+        if (ch == '\\' || ch == '"') {
+            result += '\\';
+        }
+        result += ch;
+    }
+    return result + "\"\n";
+}
+
 void ProcessRunner::BuildAndRun(const std::string& filename,
+                                const std::string& source,
+                                RunMode mode,
                                 const std::function<void(const std::string&)>& print,
-                                const std::function<void(const std::string&)>& status) {
+                                const std::function<void(const std::string&)>& status,
+                                const std::function<void(const std::string&)>& report) {
     using std::tie;
     auto err = std::error_code();
     auto out = bp::ipstream();
+    auto src = bp::opstream();
     auto exe = (bf::temp_directory_path() / bf::unique_path()).string();
     auto compiler = Settings::settings.lookUpCompiler
                     ? bp::search_path(Settings::settings.compiler)
-                    : bf::path(Settings::settings.compilerPath) / Settings::settings.compiler;
+                    : bf::absolute(bf::path(Settings::settings.compilerPath) / Settings::settings.compiler);
+    // Stdin has no directory of its own, so quoted includes are looked up in the compiler's working directory first
+    auto sourceDir = filename.empty() ? bf::temp_directory_path() : bf::path(filename).parent_path();
     status("Компілюється");
-    tie(err, currentProcess) = spawn(compiler, makeArgs(filename, exe), (bp::std_err & bp::std_out) > out);
+    tie(err, currentProcess) = spawn(compiler, makeArgs(filename, exe, mode), bp::start_dir(sourceDir),
+                                     bp::std_in < src, (bp::std_err & bp::std_out) > out);
+    if (!err) {
+        src << lineDirective(filename) << source;
+        src.flush();
+    }
+    src.pipe().close();
     auto read = std::string();
     while (std::getline(out, read)) {
         if (!read.empty()) print(read + "\\n");
@@ -83,13 +121,22 @@ void ProcessRunner::BuildAndRun(const std::string& filename,
     if (err || currentProcess.exit_code()) {
         print("Компіляція провалилась\\n" + err.message());
         status("Помилка");
+        if (mode == RunMode::Profile) {
+            report("Профілювання скасовано: програму не вдалося скомпілювати\n");
+        }
         return;
     }
 
     in = bp::async_pipe(ioc);
     out = bp::ipstream();
     status("Запущено");
-    tie(err, currentProcess) = spawn(exe + ".exe", (bp::std_err & bp::std_out) > out, bp::std_in < in, ioc);
+    if (mode == RunMode::Profile) {
+        tie(err, currentProcess) = spawn(exe + ".exe", (bp::std_err & bp::std_out) > out, bp::std_in < in, ioc,
+                                         Profiler::Attach(profiler));
+    } else {
+        tie(err, currentProcess) = spawn(exe + ".exe", (bp::std_err & bp::std_out) > out, bp::std_in < in, ioc);
+    }
+    auto profiling = !err && mode == RunMode::Profile && profiler.Start(currentProcess);
     while (std::getline(out, read)) {
         if (!read.empty()) print(read);
     }
@@ -103,6 +150,18 @@ void ProcessRunner::BuildAndRun(const std::string& filename,
         status("Завершено");
     }
 
+    if (profiling) {
+        profiler.Stop();
+        auto addr2line = compiler.parent_path() / "addr2line.exe";
+        if (!bf::exists(addr2line)) {
+            addr2line = bp::search_path("addr2line");
+        }
+        report(profiler.Report(exe + ".exe", addr2line, filename, source));
+    } else if (mode == RunMode::Profile) {
+        report(err ? "Профілювання скасовано: програму не вдалося запустити\n"
+                   : "Не вдалося підключитися до процесу для профілювання\n");
+    }
+
     in.async_close();
     line.clear();
 }
@@ -5,12 +5,19 @@
 #include <vector>
 #include <functional>
 #include <boost/process.hpp>
+#include "Profiler.h"
 
 namespace bp = boost::process;
 
+enum class RunMode {
+    Normal,
+    Profile,
+};
+
 class ProcessRunner {
 private:
     bp::child currentProcess;
+    Profiler profiler;
     bp::async_pipe in;
     std::vector<char> line;
 public:
@@ -22,9 +29,14 @@ public:
 
     void Flush();
 
+    // Compiles `source` from memory; `filename` may be empty for tabs that were never saved.
+    // In RunMode::Profile the program is built with debug info and `report` receives the hot spots once it exits.
     void BuildAndRun(const std::string& filename,
+                     const std::string& source,
+                     RunMode mode,
                      const std::function<void(const std::string&)>& print,
-                     const std::function<void(const std::string&)>& status);
+                     const std::function<void(const std::string&)>& status,
+                     const std::function<void(const std::string&)>& report);
 
     void Input(char ch);
 };
@@ -0,0 +1,259 @@
+#include "Profiler.h"
+
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <boost/process/windows.hpp>
+#include <windows.h>
+#include <psapi.h>
+#include <mmsystem.h>
+
+namespace bf = boost::filesystem;
+
+namespace {
+    constexpr auto topFunctions = 10;
+    constexpr auto topLines = 15;
+
+    // addr2line wants addresses as they are laid out in the file, not where ASLR put the image.
+    // The student's toolchain may well be 32-bit, so the optional header layout depends on its magic.
+    std::uintptr_t preferredImageBase(const std::string& exe) {
+        auto file = std::ifstream(exe, std::ios::binary);
+        auto dos = IMAGE_DOS_HEADER{};
+        auto nt = IMAGE_NT_HEADERS64{};
+        file.read(reinterpret_cast<char*>(&dos), sizeof(dos));
+        file.seekg(dos.e_lfanew);
+        file.read(reinterpret_cast<char*>(&nt), sizeof(nt));
+
+        if (!file || dos.e_magic != IMAGE_DOS_SIGNATURE || nt.Signature != IMAGE_NT_SIGNATURE) {
+            return 0;
+        }
+
+        switch (nt.OptionalHeader.Magic) {
+        case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
+            return nt.OptionalHeader.ImageBase;
+        case IMAGE_NT_OPTIONAL_HDR32_MAGIC: {
+            auto nt32 = IMAGE_NT_HEADERS32{};
+            std::memcpy(&nt32, &nt, sizeof(nt32));
+            return nt32.OptionalHeader.ImageBase;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    template <typename Key>
+    std::vector<std::pair<Key, std::size_t>> hottest(const std::map<Key, std::size_t>& counts, std::size_t limit) {
+        auto result = std::vector<std::pair<Key, std::size_t>>(counts.begin(), counts.end());
+        std::stable_sort(result.begin(), result.end(), [](auto& a, auto& b) { return a.second > b.second; });
+        if (result.size() > limit) {
+            result.resize(limit);
+        }
+        return result;
+    }
+}
+
+Profiler::~Profiler() {
+    Stop();
+}
+
+void Profiler::Adopt(void* mainThread) {
+    // The handle in PROCESS_INFORMATION belongs to the child object, the profiler needs one of its own
+    auto self = GetCurrentProcess();
+    if (!DuplicateHandle(self, mainThread, self, &thread, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
+        thread = nullptr;
+        ResumeThread(mainThread);
+    }
+}
+
+bool Profiler::Start(bp::child& child) {
+    if (!thread) {
+        return false;
+    }
+
+    process = child.native_handle();
+    wow64 = false;
+#ifdef _WIN64
+    // A 32-bit program's own registers live in the WOW64 context, the native one points into wow64cpu
+    if (BOOL isWow64; IsWow64Process(process, &isWow64)) {
+        wow64 = isWow64;
+    }
+#endif
+    imageBase = imageSize = 0;
+    samples.clear();
+    total = idle = cycles = 0;
+    stopping = false;
+    sampler = std::thread(&Profiler::Loop, this);
+    ResumeThread(thread);
+    return true;
+}
+
+void Profiler::Stop() {
+    stopping = true;
+    if (sampler.joinable()) {
+        sampler.join();
+    }
+    if (thread) {
+        CloseHandle(thread);
+        thread = nullptr;
+    }
+}
+
+std::uintptr_t Profiler::InstructionPointer() {
+#ifdef _WIN64
+    if (wow64) {
+        auto context = WOW64_CONTEXT{};
+        context.ContextFlags = WOW64_CONTEXT_CONTROL;
+        return Wow64GetThreadContext(thread, &context) ? context.Eip : 0;
+    }
+
+    auto context = CONTEXT{};
+    context.ContextFlags = CONTEXT_CONTROL;
+    return GetThreadContext(thread, &context) ? context.Rip : 0;
+#else
+    auto context = CONTEXT{};
+    context.ContextFlags = CONTEXT_CONTROL;
+    return GetThreadContext(thread, &context) ? context.Eip : 0;
+#endif
+}
+
+void Profiler::Loop() {
+    timeBeginPeriod(1);
+    while (!stopping) {
+        if (!imageBase) {
+            HMODULE module;
+            DWORD needed;
+            MODULEINFO info;
+            if (EnumProcessModulesEx(process, &module, sizeof(module), &needed, LIST_MODULES_ALL)
+                && GetModuleInformation(process, module, &info, sizeof(info))) {
+                imageBase = reinterpret_cast<std::uintptr_t>(info.lpBaseOfDll);
+                imageSize = info.SizeOfImage;
+            }
+        }
+
+        // No progress since the last sample means the thread is blocked, its instruction pointer says nothing
+        if (ULONG64 now; QueryThreadCycleTime(thread, &now) && now - cycles < idleCycles) {
+            ++idle;
+            std::this_thread::sleep_for(interval);
+            continue;
+        }
+
+        if (SuspendThread(thread) == static_cast<DWORD>(-1)) {
+            break;
+        }
+        if (auto address = InstructionPointer(); address) {
+            ++samples[address];
+            ++total;
+        }
+        ResumeThread(thread);
+
+        // Taken after resuming, so the APCs the sample itself ran in the thread aren't mistaken for progress
+        if (ULONG64 now; QueryThreadCycleTime(thread, &now)) {
+            cycles = now;
+        }
+
+        std::this_thread::sleep_for(interval);
+    }
+    timeEndPeriod(1);
+}
+
+std::string Profiler::Report(const std::string& exe,
+                             const bf::path& addr2line,
+                             const std::string& filename,
+                             const std::string& source) {
+    if (!total) {
+        return idle ? "Програма весь час очікувала (введення, sleep), процесорний час не витрачено\n"
+                    : "Програма завершилась до першої вибірки\n";
+    }
+
+    auto preferredBase = preferredImageBase(exe);
+    auto addresses = std::vector<std::pair<std::uintptr_t, std::size_t>>();
+    auto outside = std::size_t();
+    for (auto [address, count] : samples) {
+        if (imageBase && preferredBase && address >= imageBase && address < imageBase + imageSize) {
+            addresses.emplace_back(address - imageBase + preferredBase, count);
+        } else {
+            outside += count;
+        }
+    }
+
+    auto percent = [this](std::size_t count) { return 100.0 * count / total; };
+    auto report = std::format("Вибірок: {} (кожні {} мс), поза програмою (бібліотеки, ОС): {:.1f}%\n"
+                              "Очікування (введення, sleep): {} вибірок, у відсотки не враховано\n",
+                              total, interval.count(), percent(outside), idle);
+    if (addresses.empty()) {
+        return report;
+    }
+
+    // Addresses go through a response file, there can be more of them than fit on a command line
+    auto list = bf::temp_directory_path() / bf::unique_path();
+    {
+        auto file = std::ofstream(list.string());
+        for (auto [address, count] : addresses) {
+            file << std::format("{:#x}\n", address);
+        }
+    }
+
+    auto err = std::error_code();
+    auto out = bp::ipstream();
+    auto symbolizer = bp::child(addr2line, "-f", "-C", "-e", exe, "@" + list.string(),
+                                bp::std_out > out, err, bp::windows::create_no_window);
+    if (err) {
+        bf::remove(list);
+        return report + "Не вдалося запустити addr2line\n" + err.message() + '\n';
+    }
+
+    auto functions = std::map<std::string, std::size_t>();
+    auto lines = std::map<std::pair<std::string, unsigned>, std::size_t>();
+    auto function = std::string();
+    auto location = std::string();
+    for (auto [address, count] : addresses) {
+        if (!std::getline(out, function) || !std::getline(out, location)) {
+            break;
+        }
+        function.erase(function.find_last_not_of('\r') + 1);
+        location.erase(location.find_last_not_of('\r') + 1);
+        if (auto discriminator = location.find(" (discriminator"); discriminator != std::string::npos) {
+            location.erase(discriminator);
+        }
+
+        functions[function] += count;
+        if (auto colon = location.rfind(':'); colon != std::string::npos && location.compare(0, 2, "??")) {
+            auto line = static_cast<unsigned>(std::strtoul(location.c_str() + colon + 1, nullptr, 10));
+            lines[{location.substr(0, colon), line}] += count;
+        }
+    }
+    symbolizer.wait();
+    bf::remove(list);
+
+    auto sourceLines = std::vector<std::string>();
+    auto stream = std::istringstream(source);
+    for (auto line = std::string(); std::getline(stream, line);) {
+        sourceLines.emplace_back(line);
+    }
+
+    report += "\nФункції:\n";
+    for (auto& [name, count] : hottest(functions, topFunctions)) {
+        report += std::format("{:6.1f}% {:7}  {}\n", percent(count), count, name);
+    }
+
+    // addr2line may prefix the name with the compilation directory, so only compare the last component
+    auto sourceName = filename.empty() ? bf::path("<stdin>") : bf::path(filename).filename();
+
+    report += "\nРядки:\n";
+    for (auto& [key, count] : hottest(lines, topLines)) {
+        auto& [file, line] = key;
+        auto text = std::string();
+        if (bf::path(file).filename() == sourceName && line && line <= sourceLines.size()) {
+            text = sourceLines[line - 1];
+            text.erase(0, text.find_first_not_of(" \t"));
+        }
+        report += std::format("{:6.1f}% {:7}  {}:{}  {}\n",
+                              percent(count), count, bf::path(file).filename().string(), line, text);
+    }
+
+    return report;
+}
@@ -0,0 +1,78 @@
+#ifndef C_EDIT_PROFILER_H
+#define C_EDIT_PROFILER_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <boost/process.hpp>
+#include <boost/process/extend.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/winapi/process.hpp>
+
+namespace bp = boost::process;
+
+// Sampling profiler: a timer thread periodically suspends the child's main thread and records its
+// instruction pointer. Ticks where the thread barely ran since the previous sample (blocked in cin,
+// Sleep and so on) are only counted as waiting, so the percentages reflect CPU time.
+// Samples are symbolized afterwards with addr2line against the DWARF line tables of the executable,
+// which is why the program has to be built with -g.
+class Profiler {
+private:
+    static constexpr auto interval = std::chrono::milliseconds(1);
+    // Suspending the thread and reading its context cost it a few thousand cycles of kernel APCs,
+    // a busy tick is millions, so anything below this is the sampler's own overhead
+    static constexpr std::uint64_t idleCycles = 100'000;
+
+    void* process = nullptr;
+    void* thread = nullptr;
+    bool wow64 = false;
+    std::uintptr_t imageBase = 0;
+    std::uintptr_t imageSize = 0;
+    std::unordered_map<std::uintptr_t, std::size_t> samples;
+    std::size_t total = 0;
+    std::size_t idle = 0;
+    std::uint64_t cycles = 0;
+    std::atomic<bool> stopping = false;
+    std::thread sampler;
+
+    // Must be called with the thread suspended, 0 if its context couldn't be read
+    std::uintptr_t InstructionPointer();
+    void Loop();
+    void Adopt(void* mainThread);
+public:
+    // Passed to the spawn of the program: it is created suspended and its main thread is handed
+    // straight from CreateProcess to the profiler, so sampling covers the program from the first instruction.
+    struct Attach : bp::extend::handler {
+        Profiler& profiler;
+
+        explicit Attach(Profiler& profiler) : profiler{ profiler } {}
+
+        template <typename Executor>
+        void on_setup(Executor& exec) const {
+            exec.creation_flags |= boost::winapi::CREATE_SUSPENDED_;
+        }
+
+        template <typename Executor>
+        void on_success(Executor& exec) const {
+            profiler.Adopt(exec.proc_info.hThread);
+        }
+    };
+
+    ~Profiler();
+
+    // Begins sampling a child spawned with Attach and lets it run. If it fails, the child is already running.
+    bool Start(bp::child& child);
+
+    void Stop();
+
+    std::string Report(const std::string& exe,
+                       const boost::filesystem::path& addr2line,
+                       const std::string& filename,
+                       const std::string& source);
+};
+
+
+#endif //C_EDIT_PROFILER_H
@@ -2,6 +2,7 @@
 
 Settings::settings_t Settings::settings = {
         .lookUpCompiler = true,
+        .syncOnSave = true,
         .compiler = "g++.exe",
         .width = 800,
         .height = 600,
@@ -49,8 +50,10 @@ void Settings::OnDOMReady(ul::View *caller, uint64_t frame_id, bool is_main_fram
     global["OnCompilerChange"] = OnSettingsChange(compiler);
     global["OnLookUpChange"] = OnSettingsChangeBoolean(lookUpCompiler);
     global["OnSaveTabsChange"] = OnSettingsChangeBoolean(saveTabs);
+    global["OnSyncOnSaveChange"] = OnSettingsChangeBoolean(syncOnSave);
 
     ul::JSEval(("lookUpCompiler.checked = " + std::to_string(settings.lookUpCompiler)).c_str());
+    ul::JSEval(("syncOnSave.checked = " + std::to_string(settings.syncOnSave)).c_str());
     ul::JSEval(("bin.value = '" + settings.compilerPath + '\'').c_str());
     ul::JSEval(("flags.value = '" + settings.flags + '\'').c_str());
     ul::JSEval(("include.value = '" + settings.includePath + '\'').c_str());
@@ -15,6 +15,7 @@ public:
     static struct settings_t {
         bool lookUpCompiler;
         bool saveTabs;
+        bool syncOnSave;
         std::string compilerPath;
         std::string flags;
         std::string includePath;
@@ -26,6 +26,10 @@ auto main() -> int {
         }
 
         dat >> settings.terminalHidden;
+
+        if (bool syncOnSave; dat >> syncOnSave) {
+            settings.syncOnSave = syncOnSave;
+        }
     }
 
     App().run();